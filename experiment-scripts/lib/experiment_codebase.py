@@ -40,6 +40,9 @@ class ExperimentCodebase(abc.ABC):
             remote_exp_directory):
         pass
 
+    def get_in_process_cmd(self, config, run, local_exp_directory):
+        raise NotImplementedError('%s does not support in-process runs' % type(self).__name__)
+
     def prepare_local_exp_directory(self, config, config_file):
         exp_directory = get_timestamped_exp_dir(config)
         os.makedirs(exp_directory)
@@ -77,6 +80,10 @@ def get_replica_cmd(config, i, k, group, run, local_exp_directory,
     return __BUILDERS__[config['codebase_name']].get_replica_cmd(config,
             i, k, group, run, local_exp_directory, remote_exp_directory)
 
+def get_in_process_cmd(config, run, local_exp_directory):
+    return __BUILDERS__[config['codebase_name']].get_in_process_cmd(config,
+            run, local_exp_directory)
+
 def prepare_local_exp_directory(config, config_file):
     return __BUILDERS__[config['codebase_name']].prepare_local_exp_directory(config, config_file)
 
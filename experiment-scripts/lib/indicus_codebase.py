@@ -24,18 +24,45 @@
 
 '''
 import ipaddress
+import json
+import shlex
+import shutil
 
 from lib.experiment_codebase import *
 
+IN_PROCESS_LAYOUT_FILE = 'in-process-layout.json'
+IN_PROCESS_REPLICA_FLAGFILE = 'in-process-replica.flags'
+
+def get_process_cores(cores, process_idx, total_processes):
+    # split the pinned cores of a machine evenly across its server processes
+    process_cores = cores[process_idx % total_processes::total_processes]
+    if len(process_cores) == 0:
+        process_cores = [cores[process_idx % len(cores)]]
+    return process_cores
+
+def is_wal_cleared(config):
+    # the WAL of a previous experiment is only kept if replicas recover from it
+    if not 'server_wal_directory' in config or not 'server_durable' in config or not config['server_durable']:
+        return False
+    return not 'server_recover_from_wal' in config or not config['server_recover_from_wal']
+
+def get_wal_dir(config, group, replica_idx, process_idx):
+    # every replica process logs to its own subdirectory of server_wal_directory,
+    # so replicas sharing a machine (or all of them under run_locally) never
+    # append to the same log; clearing server_wal_directory clears all of them
+    return os.path.join(config['server_wal_directory'],
+            'wal-%d-%d-%d' % (group, replica_idx, process_idx))
+
 class IndicusCodebase(ExperimentCodebase):
 
     def get_client_cmd(self, config, i, j, k, run, local_exp_directory,
-            remote_exp_directory):
+            remote_exp_directory, in_process=False):
         name, _ = os.path.splitext(config['network_config_file_name'])
         closest_replica = i // config['num_groups'] if config['server_emulate_wan'] else -1
         if 'run_locally' in config and config['run_locally']:
             path_to_client_bin = os.path.join(config['src_directory'],
-                    config['bin_directory_name'], config['client_bin_name'])
+                    config['bin_directory_name'],
+                    config['in_process_bin_name'] if in_process else config['client_bin_name'])
             exp_directory = local_exp_directory
             config_path = os.path.join(local_exp_directory, config['network_config_file_name'])
             stats_file = os.path.join(exp_directory,
@@ -70,8 +97,29 @@ class IndicusCodebase(ExperimentCodebase):
             '--num_clients', client_threads,
             '--num_client_hosts', config['client_total']]])
 
+        #all replicas and clients run as threads of one process over the simulated transport
+        if in_process:
+            client_command += ' --in_process=true'
+            client_command += ' --in_process_clients %d' % config['client_total']
+            client_command += ' --in_process_layout %s' % os.path.join(local_exp_directory, IN_PROCESS_LAYOUT_FILE)
+            client_command += ' --in_process_replica_flagfile %s' % os.path.join(local_exp_directory, IN_PROCESS_REPLICA_FLAGFILE)
+            client_command += ' --in_process_replica_stats_file %s' % os.path.join(local_exp_directory,
+                    config['out_directory_name'], 'server-%d', 'server-%%d-%%d-stats-%d.json' % run)
+            # each client writes its own log and stats under the names of a distributed run
+            client_command += ' --in_process_client_log_file %s' % os.path.join(local_exp_directory,
+                    config['out_directory_name'], 'client-%d-%d', 'client-%%d-%%d-%%d-stdout-%d.log' % run)
+            client_command += ' --in_process_client_stats_file %s' % os.path.join(local_exp_directory,
+                    config['out_directory_name'], 'client-%d-%d', 'client-%%d-%%d-%%d-stats-%d.json' % run)
+
         if config['server_emulate_wan']:
             client_command += ' --ping_replicas=true'
+        #reads and the latency-critical P1 quorum go to the replicas with the lowest live RTT estimate
+        if 'client_replica_selection' in config:
+            client_command += ' --replica_selection %s' % config['client_replica_selection']
+            if config['client_replica_selection'] == 'rtt' and not config['server_emulate_wan']:
+                client_command += ' --ping_replicas=true'
+        if 'client_rtt_probe_interval_ms' in config:
+            client_command += ' --rtt_probe_interval_ms %d' % config['client_rtt_probe_interval_ms']
 
         if config['replication_protocol'] == 'tapir':
             if 'sync_commit' in config['replication_protocol_settings']:
@@ -79,6 +127,8 @@ class IndicusCodebase(ExperimentCodebase):
 
         if 'message_transport_type' in config['replication_protocol_settings']:
             client_command += ' --trans_protocol %s' % config['replication_protocol_settings']['message_transport_type']
+        if 'zero_copy' in config['replication_protocol_settings']:
+            client_command += ' --trans_zero_copy=%s' % str(config['replication_protocol_settings']['zero_copy']).lower()
 
         if config['replication_protocol'] == 'indicus' or config['replication_protocol'] == 'pbft' or config['replication_protocol'] == 'hotstuff' or config['replication_protocol'] == 'bftsmart' or config['replication_protocol'] == 'augustus':
             if 'read_quorum' in config['replication_protocol_settings']:
@@ -104,8 +154,35 @@ class IndicusCodebase(ExperimentCodebase):
                 client_command += ' --indicus_sig_batch %d' % config['replication_protocol_settings']['sig_batch']
             if 'merkle_branch_factor' in config['replication_protocol_settings']:
                 client_command += ' --indicus_merkle_branch_factor %d' % config['replication_protocol_settings']['merkle_branch_factor']
+            if 'merkle_cache_size' in config['replication_protocol_settings']:
+                client_command += ' --indicus_merkle_cache_size %d' % config['replication_protocol_settings']['merkle_cache_size']
+            #per-phase latency histograms (<phase>_hist lists in the stats file)
+            if 'phase_stats' in config['replication_protocol_settings']:
+                client_command += ' --indicus_phase_stats=%s' % str(config['replication_protocol_settings']['phase_stats']).lower()
+            if 'phase_stats_sub_buckets' in config['replication_protocol_settings']:
+                client_command += ' --indicus_phase_stats_sub_buckets %d' % config['replication_protocol_settings']['phase_stats_sub_buckets']
+            #per-transaction arena for txn state and protobufs, recycled through a per-thread pool
+            if 'txn_arena' in config['replication_protocol_settings']:
+                client_command += ' --indicus_txn_arena=%s' % str(config['replication_protocol_settings']['txn_arena']).lower()
+            if 'txn_arena_block_size' in config['replication_protocol_settings']:
+                client_command += ' --indicus_txn_arena_block_size %d' % config['replication_protocol_settings']['txn_arena_block_size']
+            if 'txn_arena_pool_size' in config['replication_protocol_settings']:
+                client_command += ' --indicus_txn_arena_pool_size %d' % config['replication_protocol_settings']['txn_arena_pool_size']
+            #read-only txns read committed state at a snapshot below the watermark and skip P1/writeback
+            if 'ro_fast_path' in config['replication_protocol_settings']:
+                client_command += ' --indicus_ro_fast_path=%s' % str(config['replication_protocol_settings']['ro_fast_path']).lower()
+            if 'ro_snapshot_lag_ms' in config['replication_protocol_settings']:
+                client_command += ' --indicus_ro_snapshot_lag_ms %d' % config['replication_protocol_settings']['ro_snapshot_lag_ms']
+            #commit certificates of recently seen txn digests; repeat proofs in read replies are referenced by digest
+            if 'cert_cache_size' in config['replication_protocol_settings']:
+                client_command += ' --indicus_cert_cache_size %d' % config['replication_protocol_settings']['cert_cache_size']
             if 'p1DecisionTimeout' in config['replication_protocol_settings']:
                 client_command += ' --indicus_phase1DecisionTimeout %d' % config['replication_protocol_settings']['p1DecisionTimeout']
+            #stop waiting for a fast quorum once the missing replies cannot arrive within p1DecisionTimeout
+            if 'adaptive_p1_decision' in config['replication_protocol_settings']:
+                client_command += ' --indicus_adaptive_p1_decision=%s' % str(config['replication_protocol_settings']['adaptive_p1_decision']).lower()
+            if 'p1_reply_latency_percentile' in config['replication_protocol_settings']:
+                client_command += ' --indicus_p1_reply_latency_percentile %d' % config['replication_protocol_settings']['p1_reply_latency_percentile']
             if 'max_consecutive_abstains' in config['replication_protocol_settings']:
                 client_command += ' --indicus_max_consecutive_abstains %d' % config['replication_protocol_settings']['max_consecutive_abstains']
 
@@ -132,6 +209,15 @@ class IndicusCodebase(ExperimentCodebase):
                 client_command += ' --indicus_relayP1_timeout %d' % config['replication_protocol_settings']['relayP1_timeout']
             if 'all_to_all_fb' in config['replication_protocol_settings']:
                 client_command += ' --indicus_all_to_all_fb=%s' % str(config['replication_protocol_settings']['all_to_all_fb']).lower()
+            if 'fb_batch' in config['replication_protocol_settings']:
+                client_command += ' --indicus_fb_batch=%s' % str(config['replication_protocol_settings']['fb_batch']).lower()
+            #P1/P2/writeback messages of concurrent txns to the same group share one message and signature
+            if 'group_msg_batch' in config['replication_protocol_settings']:
+                client_command += ' --indicus_group_msg_batch=%s' % str(config['replication_protocol_settings']['group_msg_batch']).lower()
+            if 'group_msg_batch_size' in config['replication_protocol_settings']:
+                client_command += ' --indicus_group_msg_batch_size %d' % config['replication_protocol_settings']['group_msg_batch_size']
+            if 'group_msg_batch_timeout' in config['replication_protocol_settings']:
+                client_command += ' --indicus_group_msg_batch_timeout %d' % config['replication_protocol_settings']['group_msg_batch_timeout']
             #pbft/hotstuff options
             if 'order_commit' in config['replication_protocol_settings']:
                 client_command += ' --pbft_order_commit=%s' % str(config['replication_protocol_settings']['order_commit']).lower()
@@ -173,9 +259,33 @@ class IndicusCodebase(ExperimentCodebase):
             client_command += ' --max_backoff %d' % config['client_max_backoff']
         if 'client_rand_sleep' in config:
             client_command += ' --delay %d' % config['client_rand_sleep']
+        #per-key retry scheduler: backoff grows with the recent abort history of the keys a txn touches
+        if 'client_retry_scheduler' in config:
+            client_command += ' --retry_scheduler %s' % config['client_retry_scheduler']
+        if 'client_retry_key_ranges' in config:
+            client_command += ' --retry_key_ranges %d' % config['client_retry_key_ranges']
+        if 'client_retry_history_ms' in config:
+            client_command += ' --retry_history_ms %d' % config['client_retry_history_ms']
+        #pipelined/open-loop clients: each client thread keeps several transactions in flight
+        if 'client_outstanding_txns' in config:
+            client_command += ' --outstanding_txns %d' % config['client_outstanding_txns']
+        if 'client_arrival_rate' in config:
+            client_command += ' --arrival_rate %f' % config['client_arrival_rate']
+            if 'client_arrival_distribution' in config:
+                client_command += ' --arrival_distribution %s' % config['client_arrival_distribution']
+        #latencies are recorded in fixed-size per-op histograms and only every n-th op is logged
+        if 'client_latency_hist' in config:
+            client_command += ' --latency_hist=%s' % str(config['client_latency_hist']).lower()
+        if 'client_latency_hist_sub_buckets' in config:
+            client_command += ' --latency_hist_sub_buckets %d' % config['client_latency_hist_sub_buckets']
+        if 'client_latency_sample_rate' in config:
+            client_command += ' --latency_sample_rate %d' % config['client_latency_sample_rate']
 
         if 'partitioner' in config:
             client_command += ' --partitioner %s' % config['partitioner']
+        #hotkey partitioner (pending binary support): clients and replicas start from the same mapping of keys to hash ranges
+        if 'partitioner_key_ranges' in config:
+            client_command += ' --partitioner_key_ranges %d' % config['partitioner_key_ranges']
 
         if config['benchmark_name'] == 'retwis':
             client_command += ' --num_keys %d' % config['client_num_keys']
@@ -216,7 +326,15 @@ class IndicusCodebase(ExperimentCodebase):
         if 'client_wrap_command' in config and len(config['client_wrap_command']) > 0:
             client_command = config['client_wrap_command'] % client_command
 
-        if 'run_locally' in config and config['run_locally']:
+        if in_process:
+            stdout_file = os.path.join(exp_directory,
+                    config['out_directory_name'], 'in-process-stdout-%d.log' % run)
+            stderr_file = os.path.join(exp_directory,
+                    config['out_directory_name'], 'in-process-stderr-%d.log' % run)
+
+            client_command = '%s 1> %s 2> %s' % (client_command, stdout_file,
+                    stderr_file)
+        elif 'run_locally' in config and config['run_locally']:
             stdout_file = os.path.join(exp_directory,
                     config['out_directory_name'],
                     'client-%d-%d' % (i, j),
@@ -242,7 +360,16 @@ class IndicusCodebase(ExperimentCodebase):
                 client_command = tcsh_redirect_output_to_files(client_command,
                     stdout_file, stderr_file)
 
-        if 'pin_client_processes' in config and isinstance(config['pin_client_processes'], list) and len(config['pin_client_processes']) > 0:
+        if in_process:
+            # the single process gets every core pinned for servers or clients
+            mask = 0
+            for key in ['pin_server_processes', 'pin_client_processes']:
+                if key in config and isinstance(config[key], list):
+                    for core in config[key]:
+                        mask |= 1 << core
+            if mask != 0:
+                client_command = 'taskset 0x%x %s' % (mask, client_command)
+        elif 'pin_client_processes' in config and isinstance(config['pin_client_processes'], list) and len(config['pin_client_processes']) > 0:
             core = config['pin_client_processes'][k % len(config['pin_client_processes'])]
             client_command = 'taskset 0x%x %s' % (1 << core, client_command)
 
@@ -262,7 +389,7 @@ class IndicusCodebase(ExperimentCodebase):
         return client_command
 
     def get_replica_cmd(self, config, i, k, group, run, local_exp_directory,
-            remote_exp_directory):
+            remote_exp_directory, flags_only=False):
         name, ext = os.path.splitext(config['network_config_file_name'])
         if  'run_locally' in config and config['run_locally']:
             path_to_server_bin = os.path.join(config['src_directory'],
@@ -303,10 +430,14 @@ class IndicusCodebase(ExperimentCodebase):
 
         #add multiple processes commands for threadpool assignments.
         replica_command += ' --indicus_process_id %d' % k
-        replica_command += ' --indicus_total_processes %d' % max(1, (config['num_groups'] * n) // len(config['server_names']))
+        total_processes = max(1, (config['num_groups'] * n) // len(config['server_names']))
+        replica_command += ' --indicus_total_processes %d' % total_processes
+        work_stealing = 'work_stealing' in config['replication_protocol_settings'] and config['replication_protocol_settings']['work_stealing']
 
         if 'message_transport_type' in config['replication_protocol_settings']:
             replica_command += ' --trans_protocol %s' % config['replication_protocol_settings']['message_transport_type']
+        if 'zero_copy' in config['replication_protocol_settings']:
+            replica_command += ' --trans_zero_copy=%s' % str(config['replication_protocol_settings']['zero_copy']).lower()
 
         if config['replication_protocol'] == 'strong':
             if 'strongmode' in config['replication_protocol_settings']:
@@ -328,6 +459,15 @@ class IndicusCodebase(ExperimentCodebase):
                 replica_command += ' --indicus_read_dep %s' % config['replication_protocol_settings']['read_dep']
             if 'watermark_time_delta' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_time_delta %d' % config['replication_protocol_settings']['watermark_time_delta']
+            #incremental background GC of versions, certificates and fallback state below the low watermark
+            if 'gc' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_gc=%s' % str(config['replication_protocol_settings']['gc']).lower()
+            if 'gc_interval_ms' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_gc_interval_ms %d' % config['replication_protocol_settings']['gc_interval_ms']
+            if 'gc_batch' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_gc_batch %d' % config['replication_protocol_settings']['gc_batch']
+            if 'rss_sample_interval_ms' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_rss_sample_interval_ms %d' % config['replication_protocol_settings']['rss_sample_interval_ms']
             if 'sign_messages' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_sign_messages=%s' % str(config['replication_protocol_settings']['sign_messages']).lower()
                 replica_command += ' --indicus_key_path %s' % config['replication_protocol_settings']['key_path']
@@ -339,6 +479,9 @@ class IndicusCodebase(ExperimentCodebase):
                 replica_command += ' --indicus_verify_deps=%s' % str(config['replication_protocol_settings']['verify_deps']).lower()
             if 'max_dep_depth' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_max_dep_depth %d' % config['replication_protocol_settings']['max_dep_depth']
+            #depth of each prepared txn is kept from prepare until commit/abort instead of walked per read
+            if 'dep_depth_index' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_dep_depth_index=%s' % str(config['replication_protocol_settings']['dep_depth_index']).lower()
             if 'signature_type' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_key_type %d' % config['replication_protocol_settings']['signature_type']
             if 'sig_batch' in config['replication_protocol_settings']:
@@ -347,16 +490,60 @@ class IndicusCodebase(ExperimentCodebase):
                 replica_command += ' --indicus_sig_batch_timeout %d' % config['replication_protocol_settings']['sig_batch_timeout']
             if 'occ_type' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_occ_type %s' % config['replication_protocol_settings']['occ_type']
+            if 'store_type' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_store_type %s' % config['replication_protocol_settings']['store_type']
+            #key index of the store: node-based map or flat open-addressing table keyed by 64-bit key hash
+            if 'store_index' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_store_index %s' % config['replication_protocol_settings']['store_index']
+            if 'store_index_prefetch' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_store_index_prefetch=%s' % str(config['replication_protocol_settings']['store_index_prefetch']).lower()
             if 'read_reply_batch' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_read_reply_batch=%s' % str(config['replication_protocol_settings']['read_reply_batch']).lower()
+            if 'read_reply_dedup_certs' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_read_reply_dedup_certs=%s' % str(config['replication_protocol_settings']['read_reply_dedup_certs']).lower()
+            if 'group_msg_batch' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_group_msg_batch=%s' % str(config['replication_protocol_settings']['group_msg_batch']).lower()
             if 'adjust_batch_size' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_adjust_batch_size=%s' % str(config['replication_protocol_settings']['adjust_batch_size']).lower()
+            #closed-loop batch size controller; sig_batch/sig_batch_timeout become the starting point
+            if 'adaptive_batch' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_adaptive_batch=%s' % str(config['replication_protocol_settings']['adaptive_batch']).lower()
+            if 'sig_batch_min' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_sig_batch_min %d' % config['replication_protocol_settings']['sig_batch_min']
+            if 'sig_batch_max' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_sig_batch_max %d' % config['replication_protocol_settings']['sig_batch_max']
+            if 'sig_batch_timeout_max' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_sig_batch_timeout_max %d' % config['replication_protocol_settings']['sig_batch_timeout_max']
+            if 'adaptive_batch_interval_ms' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_adaptive_batch_interval_ms %d' % config['replication_protocol_settings']['adaptive_batch_interval_ms']
             if 'shared_mem_batch' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_shared_mem_batch=%s' % str(config['replication_protocol_settings']['shared_mem_batch']).lower()
             if 'shared_mem_verify' in config['replication_protocol_settings']:
-                replica_command += ' --indicus_shared_mem_verify=%s' % str(config['replication_protocol_settings']['shared_mem_batch']).lower()
+                replica_command += ' --indicus_shared_mem_verify=%s' % str(config['replication_protocol_settings']['shared_mem_verify']).lower()
+            #slots of the ring that the co-located replica processes use to feed the host-wide batch signer
+            if 'shared_mem_ring_size' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_shared_mem_ring_size %d' % config['replication_protocol_settings']['shared_mem_ring_size']
             if 'merkle_branch_factor' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_merkle_branch_factor %d' % config['replication_protocol_settings']['merkle_branch_factor']
+            if 'merkle_cache_size' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_merkle_cache_size %d' % config['replication_protocol_settings']['merkle_cache_size']
+            #per-phase latency histograms (<phase>_hist lists in the stats file)
+            if 'phase_stats' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_phase_stats=%s' % str(config['replication_protocol_settings']['phase_stats']).lower()
+            if 'phase_stats_sub_buckets' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_phase_stats_sub_buckets %d' % config['replication_protocol_settings']['phase_stats_sub_buckets']
+            #per-transaction arena for txn state and protobufs, recycled through a per-thread pool
+            if 'txn_arena' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_txn_arena=%s' % str(config['replication_protocol_settings']['txn_arena']).lower()
+            if 'txn_arena_block_size' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_txn_arena_block_size %d' % config['replication_protocol_settings']['txn_arena_block_size']
+            if 'txn_arena_pool_size' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_txn_arena_pool_size %d' % config['replication_protocol_settings']['txn_arena_pool_size']
+            #read-only txns read committed state at a snapshot below the watermark and skip P1/writeback
+            if 'ro_fast_path' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_ro_fast_path=%s' % str(config['replication_protocol_settings']['ro_fast_path']).lower()
+            if 'ro_snapshot_lag_ms' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_ro_snapshot_lag_ms %d' % config['replication_protocol_settings']['ro_snapshot_lag_ms']
             if 'batch_tout' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_sig_batch_timeout %d' % config['replication_protocol_settings']['batch_tout']
             if 'batch_size' in config['replication_protocol_settings']:
@@ -372,6 +559,12 @@ class IndicusCodebase(ExperimentCodebase):
                 replica_command += ' --indicus_multi_threading=%s' % str(config['replication_protocol_settings']['multi_threading']).lower()
             if 'batch_verification' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_batch_verification=%s' % str(config['replication_protocol_settings']['batch_verification']).lower()
+            if 'batch_verification_size' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_batch_verification_size %d' % config['replication_protocol_settings']['batch_verification_size']
+            if 'batch_verification_timeout' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_batch_verification_timeout %d' % config['replication_protocol_settings']['batch_verification_timeout']
+            if 'verification_simd' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_verification_simd %s' % config['replication_protocol_settings']['verification_simd']
             if 'mainThreadDispatching' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_mainThreadDispatching=%s' % str(config['replication_protocol_settings']['mainThreadDispatching']).lower()
             if 'dispatchMessageReceive' in config['replication_protocol_settings']:
@@ -382,6 +575,11 @@ class IndicusCodebase(ExperimentCodebase):
                 replica_command += ' --indicus_dispatchCallbacks=%s' % str(config['replication_protocol_settings']['dispatchCallbacks']).lower()
             if 'parallel_CCC' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_parallel_CCC=%s' % str(config['replication_protocol_settings']['parallel_CCC']).lower()
+            #unified work-stealing executor; replaces the main thread/worker pool handoffs above
+            if 'work_stealing' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_work_stealing=%s' % str(config['replication_protocol_settings']['work_stealing']).lower()
+                if work_stealing and 'pin_server_processes' in config and isinstance(config['pin_server_processes'], list) and len(config['pin_server_processes']) > 0:
+                    replica_command += ' --indicus_worker_cores %s' % ','.join([str(c) for c in get_process_cores(config['pin_server_processes'], k, total_processes)])
 
             #disable hyperthreading and boosting
             if 'hyper_threading' in config['replication_protocol_settings']:
@@ -395,12 +593,28 @@ class IndicusCodebase(ExperimentCodebase):
                 replica_command += ' --indicus_all_to_all_fb=%s' % str(config['replication_protocol_settings']['all_to_all_fb']).lower()
             if 'replica_gossip' in config['replication_protocol_settings']:
                 replica_command += ' --indicus_replica_gossip=%s' % str(config['replication_protocol_settings']['replica_gossip']).lower()
+            #fallback messages are batched per dependency set and checked by the batch verifier; independent fallbacks run on the worker pool
+            if 'fb_batch' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_fb_batch=%s' % str(config['replication_protocol_settings']['fb_batch']).lower()
+            if 'fb_batch_size' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_fb_batch_size %d' % config['replication_protocol_settings']['fb_batch_size']
+            if 'fb_batch_timeout' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_fb_batch_timeout %d' % config['replication_protocol_settings']['fb_batch_timeout']
+            if 'parallel_fb' in config['replication_protocol_settings']:
+                replica_command += ' --indicus_parallel_fb=%s' % str(config['replication_protocol_settings']['parallel_fb']).lower()
                 
             #pbft/hotstuff options
             if 'order_commit' in config['replication_protocol_settings']:
                 replica_command += ' --pbft_order_commit=%s' % str(config['replication_protocol_settings']['order_commit']).lower()
             if 'validate_abort' in config['replication_protocol_settings']:
                 replica_command += ' --pbft_validate_abort=%s' % str(config['replication_protocol_settings']['validate_abort']).lower()
+            #hotstuff leader sizes each proposed block by its queue depth, bounded by the batch_size set with src/scripts/batch_size
+            if 'hotstuff_dynamic_batch' in config['replication_protocol_settings']:
+                replica_command += ' --hotstuff_dynamic_batch=%s' % str(config['replication_protocol_settings']['hotstuff_dynamic_batch']).lower()
+            if 'hotstuff_batch_size_min' in config['replication_protocol_settings']:
+                replica_command += ' --hotstuff_batch_size_min %d' % config['replication_protocol_settings']['hotstuff_batch_size_min']
+            if 'hotstuff_batch_size_max' in config['replication_protocol_settings']:
+                replica_command += ' --hotstuff_batch_size_max %d' % config['replication_protocol_settings']['hotstuff_batch_size_max']
 
 
         #if 'rw_or_retwis' in config:
@@ -408,6 +622,13 @@ class IndicusCodebase(ExperimentCodebase):
 
         if config['replication_protocol'] == 'bftsmart':
             replica_command += " --bftsmart_codebase_dir=%s" % str(config['bftsmart_codebase_dir'])        
+            #ordered batches are delivered through direct ByteBuffers into a preallocated native ring instead of copied byte[]s
+            if 'bftsmart_direct_delivery' in config:
+                replica_command += ' --bftsmart_direct_delivery=%s' % str(config['bftsmart_direct_delivery']).lower()
+            if 'bftsmart_delivery_ring_size' in config:
+                replica_command += ' --bftsmart_delivery_ring_size %d' % config['bftsmart_delivery_ring_size']
+            if 'bftsmart_delivery_batch' in config:
+                replica_command += ' --bftsmart_delivery_batch %d' % config['bftsmart_delivery_batch']
 
         if 'server_debug_stats' in config and config['server_debug_stats']:
             replica_command += ' --debug_stats'
@@ -428,19 +649,55 @@ class IndicusCodebase(ExperimentCodebase):
             replica_command += ' --tpcc_num_warehouses %d' % config['tpcc_num_warehouses']
         elif config['benchmark_name'] == 'smallbank':
             replica_command += ' --data_file_path %s' % config['smallbank_data_file_path']
+        #snapshot written by tpcc_generator/smallbank_generator_main with --binary_output; each shard loads its partition
+        if 'server_data_file_format' in config:
+            replica_command += ' --data_file_format %s' % config['server_data_file_format']
+        if 'server_load_threads' in config:
+            replica_command += ' --load_threads %d' % config['server_load_threads']
+        #committed writes and commit certificates are appended to a per-replica WAL, fsynced once per signature batch
+        if 'server_durable' in config and config['server_durable']:
+            replica_command += ' --durable=true'
+        if 'server_wal_directory' in config:
+            replica_command += ' --wal_dir %s' % get_wal_dir(config, group, i // xx, k)
+        if 'server_wal_direct_io' in config:
+            replica_command += ' --wal_direct_io=%s' % str(config['server_wal_direct_io']).lower()
+        if 'server_wal_io_uring' in config:
+            replica_command += ' --wal_io_uring=%s' % str(config['server_wal_io_uring']).lower()
+        if 'server_wal_group_commit_timeout_us' in config:
+            replica_command += ' --wal_group_commit_timeout_us %d' % config['server_wal_group_commit_timeout_us']
+        if 'server_checkpoint_interval_ms' in config:
+            replica_command += ' --checkpoint_interval_ms %d' % config['server_checkpoint_interval_ms']
+        if 'server_recover_from_wal' in config:
+            replica_command += ' --recover_from_wal=%s' % str(config['server_recover_from_wal']).lower()
 
 
         if 'partitioner' in config:
             replica_command += ' --partitioner %s' % config['partitioner']
-
-
+        if 'partitioner_key_ranges' in config:
+            replica_command += ' --partitioner_key_ranges %d' % config['partitioner_key_ranges']
+        if 'partitioner_rebalance_interval_ms' in config:
+            replica_command += ' --partitioner_rebalance_interval_ms %d' % config['partitioner_rebalance_interval_ms']
+        if 'partitioner_rebalance_threshold' in config:
+            replica_command += ' --partitioner_rebalance_threshold %d' % config['partitioner_rebalance_threshold']
+        if 'partitioner_rebalance_max_ranges' in config:
+            replica_command += ' --partitioner_rebalance_max_ranges %d' % config['partitioner_rebalance_max_ranges']
+
+        if flags_only:
+            return replica_command
 
         if 'server_wrap_command' in config and len(config['server_wrap_command']) > 0:
             replica_command = config['server_wrap_command'] % replica_command
 
         if 'pin_server_processes' in config and isinstance(config['pin_server_processes'], list) and len(config['pin_server_processes']) > 0:
-            core = config['pin_server_processes'][k % len(config['pin_server_processes'])]
-            replica_command = 'taskset 0x%x %s' % (1 << core, replica_command)
+            if work_stealing:
+                # the executor pins one worker per core itself, so leave the process all of its cores
+                mask = 0
+                for core in get_process_cores(config['pin_server_processes'], k, total_processes):
+                    mask |= 1 << core
+                replica_command = 'taskset 0x%x %s' % (mask, replica_command)
+            else:
+                core = config['pin_server_processes'][k % len(config['pin_server_processes'])]
+                replica_command = 'taskset 0x%x %s' % (1 << core, replica_command)
 
         ## Wrapping additional information around command
         if 'run_locally' in config and config['run_locally']:
@@ -509,11 +766,95 @@ class IndicusCodebase(ExperimentCodebase):
                         print('replica %s:%d' % (config['server_names'][server_idx],
                             config['server_port'] + process_idx), file=f)
 
+        if 'run_in_process' in config and config['run_in_process']:
+            self.write_in_process_files(config, local_exp_directory)
+        if 'run_locally' in config and config['run_locally'] and is_wal_cleared(config):
+            shutil.rmtree(config['server_wal_directory'], ignore_errors=True)
+
         return local_exp_directory
 
+    def get_in_process_cmd(self, config, run, local_exp_directory):
+        client_command = self.get_client_cmd(config, 0, 0, 0, run,
+                local_exp_directory, None, True)
+        if client_command[-2:] == '& ':
+            client_command = client_command[:-2]
+        return client_command
+
+    def write_in_process_files(self, config, local_exp_directory):
+        if config['replication_protocol'] == 'indicus':
+            n = 5 * config['fault_tolerance'] + 1
+        elif config['replication_protocol'] == 'pbft' or config['replication_protocol'] == 'hotstuff' or config['replication_protocol'] == 'bftsmart' or config['replication_protocol'] == 'augustus':
+            n = 3 * config['fault_tolerance'] + 1
+        else:
+            n = 2 * config['fault_tolerance'] + 1
+        x = len(config['server_names']) // n
+        server_region = {}
+        for reg, servers in config['server_regions'].items():
+            for server_name in servers:
+                server_region[server_name] = reg
+
+        # placement of every replica and client on the emulated servers; the
+        # simulated transport delays each message by half the rtt between the
+        # regions of its endpoints
+        layout = {'groups': [], 'clients': [],
+                'region_rtt_latencies': config['region_rtt_latencies'] if config['server_emulate_wan'] else {}}
+        for group in range(config['num_groups']):
+            replicas = []
+            for i in range(n):
+                server_idx = i * x + (group % x)
+                replica = {'server_idx': server_idx,
+                    'process_idx': group // x,
+                    'region': server_region[config['server_names'][server_idx]]}
+                if 'server_wal_directory' in config:
+                    replica['wal_dir'] = get_wal_dir(config, group, i, group // x)
+                replicas.append(replica)
+            layout['groups'].append(replicas)
+        total = 0
+        for i in range(len(config['server_names'])):
+            for j in range(config['client_nodes_per_server']):
+                for k in range(config['client_processes_per_client_node']):
+                    if total >= config['client_total']:
+                        break
+                    layout['clients'].append({'client_id': i * config['client_nodes_per_server'] * config['client_processes_per_client_node'] + j * config['client_processes_per_client_node'] + k,
+                        'server_idx': i, 'node_idx': j, 'process_idx': k,
+                        'region': server_region[config['server_names'][i]]})
+                    total += 1
+        with open(os.path.join(local_exp_directory, IN_PROCESS_LAYOUT_FILE), 'w') as f:
+            json.dump(layout, f, indent=2)
+
+        # replica settings are shared by all replicas; the binary fills in
+        # replica_idx, group_idx, the stats file and the WAL directory of each one. Client and
+        # replicas share one gflags namespace, so every replica flag is renamed
+        # to replica_<flag> (e.g. --replica_indicus_multi_threading) instead of
+        # overriding the client's value of the same flag
+        replica_flags = shlex.split(self.get_replica_cmd(config, 0, 0, 0, 0,
+                local_exp_directory, None, True))[1:]
+        per_replica_flags = ['--replica_idx', '--group_idx', '--stats_file', '--wal_dir',
+                '--indicus_process_id', '--indicus_total_processes']
+        with open(os.path.join(local_exp_directory, IN_PROCESS_REPLICA_FLAGFILE), 'w') as f:
+            idx = 0
+            while idx < len(replica_flags):
+                flag = replica_flags[idx]
+                idx += 1
+                value = None
+                if '=' in flag:
+                    flag, value = flag.split('=', 1)
+                elif idx < len(replica_flags) and not replica_flags[idx].startswith('--'):
+                    value = replica_flags[idx]
+                    idx += 1
+                if flag in per_replica_flags:
+                    continue
+                flag = '--replica_' + flag[2:]
+                if value is None:
+                    print(flag, file=f)
+                else:
+                    print('%s=%s' % (flag, value), file=f)
+
     def prepare_remote_server_codebase(self, config, host, local_exp_directory, remote_out_directory):
         if config['replication_protocol'] == 'indicus' or config['replication_protocol'] == 'pbft' or config['replication_protocol'] == 'hotstuff' or config['replication_protocol'] == 'bftsmart' or config['replication_protocol'] == 'augustus':
             run_remote_command_sync('sudo rm -rf /dev/shm/*', config['emulab_user'], host)
+            if is_wal_cleared(config):
+                run_remote_command_sync('sudo rm -rf %s' % config['server_wal_directory'], config['emulab_user'], host)
 
     def setup_nodes(self, config):
         pass
@@ -0,0 +1,43 @@
+'''
+ Copyright 2021 Matthew Burke <matthelb@cs.cornell.edu>
+                Florian Suri-Payer <fsp@cs.cornell.edu>
+
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+'''
+import utils
+import sys
+
+from utils.microbench_util import *
+
+def main():
+    if len(sys.argv) != 2 and len(sys.argv) != 3:
+        sys.stderr.write('Usage: python3 %s <config_file> [<baseline_microbench_json>]\n' % sys.argv[0])
+        sys.exit(1)
+
+    config, out_file = run_microbenchmarks(sys.argv[1])
+    if len(sys.argv) == 3:
+        threshold = DEFAULT_REGRESSION_THRESHOLD if not 'microbench_regression_threshold' in config else config['microbench_regression_threshold']
+        if len(compare_microbenchmarks(sys.argv[2], out_file, threshold)) > 0:
+            sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -41,6 +41,154 @@ def convert_latency_nanos_to_millis(latencies):
 def get_num_regions(config):
     return len(config['server_names']) if not 'server_regions' in config else len(config['server_regions'])
 
+# per-phase latency histograms (phase_stats) are reported as <phase>_hist
+HIST_SUFFIX = '_hist'
+DEFAULT_HIST_SUB_BUCKETS = 16
+# periodic samples (e.g. rss_kb_timeline) are summed per sample index
+TIMELINE_SUFFIX = '_timeline'
+# with client_latency_hist, clients report the latencies of each op type as
+# lat_<op>_hist instead of logging every op
+LATENCY_HIST_PREFIX = 'lat_'
+
+def is_latency_hist(k):
+    return k.startswith(LATENCY_HIST_PREFIX) and k.endswith(HIST_SUFFIX)
+
+def get_latency_sample_rate(config):
+    if 'client_latency_sample_rate' in config and config['client_latency_sample_rate'] > 1:
+        return config['client_latency_sample_rate']
+    return 1
+
+def is_merged_list(config, k):
+    return k.endswith(HIST_SUFFIX) or k.endswith(TIMELINE_SUFFIX) or ('stats_merge_lists' in config and k in config['stats_merge_lists'])
+
+def merge_list(merged, v):
+    if len(merged) < len(v):
+        for uu in range(len(merged), len(v)):
+            merged.append(0)
+    for uu in range(len(v)):
+        merged[uu] += v[uu]
+
+def get_hist_sub_buckets(config):
+    if 'phase_stats_sub_buckets' in config['replication_protocol_settings']:
+        return config['replication_protocol_settings']['phase_stats_sub_buckets']
+    return DEFAULT_HIST_SUB_BUCKETS
+
+# same default as the client log parser: latencies are reported in millis
+def get_output_latency_scale(config):
+    if 'output_latency_scale' in config:
+        return config['output_latency_scale']
+    return 1e3
+
+def get_latency_hist_sub_buckets(config):
+    if 'client_latency_hist_sub_buckets' in config:
+        return config['client_latency_hist_sub_buckets']
+    return DEFAULT_HIST_SUB_BUCKETS
+
+# HDR-style log-linear buckets over microseconds: buckets [0, sub_buckets) hold
+# one value each, after that every further sub_buckets buckets cover twice the
+# range of the previous ones (e.g. with 16 sub buckets, bucket 40 is [48, 49])
+def get_hist_bucket_range(idx, sub_buckets):
+    if idx < sub_buckets:
+        return idx, idx
+    e = idx // sub_buckets
+    lower = (sub_buckets + idx % sub_buckets) << (e - 1)
+    return lower, lower + (1 << (e - 1)) - 1
+
+def calculate_statistics_for_hist(config, counts, sub_buckets=None):
+    if sub_buckets is None:
+        sub_buckets = get_hist_sub_buckets(config)
+    # convert from micros to the output scale of the latency stats
+    scale = get_output_latency_scale(config) / 1e6
+    total = sum(counts)
+    cum_counts = []
+    cum = 0
+    for c in counts:
+        cum += c
+        cum_counts.append(cum)
+
+    def value_at_percentile(p):
+        target = max(1, math.ceil(p / 100 * total))
+        for idx in range(len(cum_counts)):
+            if cum_counts[idx] >= target:
+                return get_hist_bucket_range(idx, sub_buckets)[1] * scale
+        return get_hist_bucket_range(len(counts) - 1, sub_buckets)[1] * scale
+
+    mean = 0
+    first_idx = -1
+    for idx in range(len(counts)):
+        if counts[idx] > 0:
+            lower, upper = get_hist_bucket_range(idx, sub_buckets)
+            mean += counts[idx] * (lower + upper) / 2
+            if first_idx < 0:
+                first_idx = idx
+    mean = mean / total * scale
+    var = 0
+    for idx in range(len(counts)):
+        if counts[idx] > 0:
+            lower, upper = get_hist_bucket_range(idx, sub_buckets)
+            var += counts[idx] * ((lower + upper) / 2 * scale - mean) ** 2
+    var = var / total
+
+    s = {
+        'p50': value_at_percentile(50),
+        'p75': value_at_percentile(75),
+        'p90': value_at_percentile(90),
+        'p95': value_at_percentile(95),
+        'p99': value_at_percentile(99),
+        'p99.9': value_at_percentile(99.9),
+        'max': value_at_percentile(100),
+        'min': get_hist_bucket_range(first_idx, sub_buckets)[0] * scale,
+        'mean': mean,
+        'stddev': math.sqrt(var),
+        'var': var,
+        'samples': total,
+    }
+    s['cdf'] = [[i, value_at_percentile(i)] for i in range(1, 100)]
+    cdf_log = []
+    base = 0
+    log_scale = 1
+    for i in range(0, 4):
+        for j in range(0, 90):
+            if i == 0 and j == 0:
+                continue
+            cdf_log.append([base + j / log_scale, value_at_percentile(base + j / log_scale)])
+        base += 90 / log_scale
+        log_scale = log_scale * 10
+    s['cdf_log'] = cdf_log
+    return s
+
+def calculate_all_hist_statistics(config, stats, hists):
+    for k, v in hists.items():
+        if sum(v) > 0 and not is_latency_hist(k):
+            stats[k[:-len(HIST_SUFFIX)]] = calculate_statistics_for_hist(config, v)
+
+# replaces the op stats computed from the logged (sampled) ops with exact ones;
+# only op types with logged ops have stats to update, the other stats of an op
+# (e.g. new_tput) are kept
+def calculate_all_latency_hist_statistics(config, stats, hists, op_latencies, total_recorded_time):
+    sub_buckets = get_latency_hist_sub_buckets(config)
+    op_hists = {}
+    for k, v in hists.items():
+        if is_latency_hist(k):
+            op_type = k[len(LATENCY_HIST_PREFIX):-len(HIST_SUFFIX)]
+            op_hists[op_type] = v
+            if not op_type in config['client_combine_stats_blacklist']:
+                if 'combined' not in op_hists:
+                    op_hists['combined'] = []
+                merge_list(op_hists['combined'], v)
+    for op_type, v in op_hists.items():
+        ops = sum(v)
+        if ops == 0 or op_type in config['client_stats_blacklist'] or not op_type in op_latencies or not op_type in stats:
+            continue
+        tput = ops / total_recorded_time
+        if 'tput_s_honest' in stats[op_type] and stats[op_type]['tput'] > 0:
+            stats[op_type]['tput_s_honest'] *= tput / stats[op_type]['tput']
+        stats[op_type].update(calculate_statistics_for_hist(config, v, sub_buckets))
+        stats[op_type]['ops'] = ops
+        stats[op_type]['tput'] = tput
+        if op_type == 'combined':
+            stats[op_type]['time'] = total_recorded_time
+
 def calculate_statistics(config, local_out_directory):
     runs = []
     op_latencies = {}
@@ -98,6 +246,16 @@ def calculate_statistics(config, local_out_directory):
         op_latencies['%s_norm' % k] = v
     for k, v in norm_op_times.items():
         op_times['%s_norm' % k] = v
+    hists = {}
+    for run in runs:
+        for k, v in run.items():
+            if k.endswith(HIST_SUFFIX) and type(v) is list:
+                if k not in hists:
+                    hists[k] = []
+                merge_list(hists[k], v)
+    calculate_all_hist_statistics(config, stats['aggregate'], hists)
+    calculate_all_latency_hist_statistics(config, stats['aggregate'], hists,
+            op_latencies, get_total_recorded_time(config))
     stats['runs'] = runs
     stats['run_stats'] = {}
     ignored = {'cdf': 1, 'cdf_log': 1, 'time': 1}
@@ -109,7 +267,10 @@ def calculate_statistics(config, local_out_directory):
                     continue
                 data = []
                 for run in runs:
-                    data.append(run[cat][s])
+                    # stats derived from histograms (e.g. phase_p2) only exist
+                    # in the runs that recorded samples for them
+                    if cat in run and s in run[cat]:
+                        data.append(run[cat][s])
                 stats['run_stats'][cat][s] = calculate_statistics_for_data(data, cdf=False)
         if 'region-' in cat:
             stats['run_stats'][cat] = {}
@@ -173,9 +334,8 @@ def calculate_statistics_for_run(config, local_out_directory, run):
                         end_time_sec = {}
                         end_time_usec = {}
                         with open(client_out_file) as f:
-                            ops = f.readlines()
                             foundEnd = False
-                            for op in ops:
+                            for op in f:
                                 foundEnd = False
                                 opCols = op.strip().split(',')
                                 for x in range(0, len(opCols), 2):
@@ -265,6 +425,7 @@ def calculate_statistics_for_run(config, local_out_directory, run):
                                     run_time_sec += end_time_usec[cid] / 1e6
                                     if cid in op_latency_counts:
                                         for k1, v in op_latency_counts[cid].items():
+                                            v = v * get_latency_sample_rate(config)
                                             print('Client %d-%d-%d %d tput %s is %f (%d / %f)' % (server_idx, j, k, cid, k1, v / run_time_sec, v, run_time_sec))
                                             if k1 in op_tputs:
                                                 op_tputs[k1] += v / run_time_sec
@@ -279,7 +440,7 @@ def calculate_statistics_for_run(config, local_out_directory, run):
                             with open(client_stats_file) as f:
                                 client_stats = json.load(f)
                                 for k1, v in client_stats.items():
-                                    if (not 'stats_merge_lists' in config) or (not k1 in config['stats_merge_lists']):
+                                    if not is_merged_list(config, k1):
                                         if k1 not in stats:
                                             stats[k1] = v
                                         else:
@@ -288,11 +449,7 @@ def calculate_statistics_for_run(config, local_out_directory, run):
                                         if k1 not in stats:
                                             stats[k1] = v
                                         else:
-                                            if len(stats[k1]) < len(v):
-                                                for uu in range(len(stats[k1]), len(v)):
-                                                    stats[k1].append(0)
-                                            for uu in range(len(v)):
-                                                stats[k1][uu] += v[uu]
+                                            merge_list(stats[k1], v)
 
                         except FileNotFoundError:
                             print('No stats file %s.' % client_stats_file)
@@ -315,7 +472,7 @@ def calculate_statistics_for_run(config, local_out_directory, run):
                         server_stats = json.load(f)
                         for k, v in server_stats.items():
                             if not type(v) is dict:
-                                if (not 'stats_merge_lists' in config) or (not k in config['stats_merge_lists']):
+                                if not is_merged_list(config, k):
                                     if k not in stats:
                                         stats[k] = v
                                     else:
@@ -324,11 +481,7 @@ def calculate_statistics_for_run(config, local_out_directory, run):
                                     if k not in stats:
                                         stats[k] = v
                                     else:
-                                        if len(stats[k]) < len(v):
-                                            for uu in range(len(stats[k]), len(v)):
-                                                stats[k].append(0)
-                                        for uu in range(len(v)):
-                                            stats[k][uu] += v[uu]
+                                        merge_list(stats[k], v)
                 except FileNotFoundError:
                     print('No stats file %s.' % server_stats_file)
                 except json.decoder.JSONDecodeError:
@@ -402,6 +555,43 @@ def calculate_statistics_for_run(config, local_out_directory, run):
             stats['fast_read_ratio'] = fr0 / (fr0 + sr0)
             stats['slow_read_ratio'] = sr0 / (fr0 + sr0)
 
+    # clients count each P1 decision as fast or slow path and report the time
+    # (in micros) spent waiting for replies beyond the first slow-path quorum
+    p1_fast = stats['p1_fast_decisions'] if 'p1_fast_decisions' in stats else 0
+    p1_slow = stats['p1_slow_decisions'] if 'p1_slow_decisions' in stats else 0
+    if p1_fast + p1_slow > 0:
+        stats['fast_path_ratio'] = p1_fast / (p1_fast + p1_slow)
+        stats['slow_path_ratio'] = p1_slow / (p1_fast + p1_slow)
+        if 'p1_straggler_wait_us' in stats:
+            stats['p1_straggler_wait_per_txn'] = stats['p1_straggler_wait_us'] * get_output_latency_scale(config) / 1e6 / (p1_fast + p1_slow)
+
+    # merged lists (txn_groups, sig_batch) are histograms indexed by value,
+    # e.g. sig_batch[b] counts the batches that were signed with size b
+    if 'stats_merge_lists' in config:
+        for k in config['stats_merge_lists']:
+            if k in stats and type(stats[k]) is list:
+                count = sum(stats[k])
+                if count > 0:
+                    stats['%s_mean' % k] = sum([b * c for b, c in enumerate(stats[k])]) / count
+
+    calculate_all_hist_statistics(config, stats, {k: v for k, v in stats.items() if k.endswith(HIST_SUFFIX) and type(v) is list})
+
+    # e.g. rss_kb_timeline[i] is the total RSS of all replicas at the i-th sample
+    for k in list(stats.keys()):
+        if k.endswith(TIMELINE_SUFFIX) and type(stats[k]) is list and len(stats[k]) > 0:
+            k_prefix = k[:-len(TIMELINE_SUFFIX)]
+            stats[k_prefix + '_start'] = stats[k][0]
+            stats[k_prefix + '_end'] = stats[k][-1]
+            stats[k_prefix + '_max'] = max(stats[k])
+
+    # caches report <name>_hits and <name>_misses (e.g. merkle_cache_hits)
+    for k in list(stats.keys()):
+        if k.endswith('_hits') and type(stats[k]) is not list:
+            k_prefix = k[:-len('_hits')]
+            k_misses = k_prefix + '_misses'
+            if k_misses in stats and stats[k] + stats[k_misses] > 0:
+                stats[k_prefix + '_hit_rate'] = stats[k] / (stats[k] + stats[k_misses])
+
     # TODO: decide if this is a hack that needs to be removed?
     total_committed = 0
     total_attempts = 0
@@ -442,6 +632,22 @@ def calculate_statistics_for_run(config, local_out_directory, run):
         stats['commit_rate_honest'] = total_committed / (total_attempts - total_abort_user)
         stats['abort_rate_honest'] = 1 - stats['commit_rate_honest']
 
+        # clients report the number of retried attempts and the time (in micros)
+        # spent on attempts that aborted
+        if 'retries' in stats and total_committed > 0:
+            stats['retries_per_commit'] = stats['retries'] / total_committed
+        if 'wasted_work_us' in stats and total_committed > 0:
+            stats['wasted_work_per_commit'] = stats['wasted_work_us'] * get_output_latency_scale(config) / 1e6 / total_committed
+        # with the hotkey partitioner, clients count the requests that a group
+        # redirected because the key range had moved
+        if 'redirects' in stats and total_committed > 0:
+            stats['redirects_per_commit'] = stats['redirects'] / total_committed
+
+    # open-loop clients issue client_arrival_rate txn/s per client thread
+    if 'client_arrival_rate' in config:
+        threads = 1 if not 'client_threads_per_process' in config else config['client_threads_per_process']
+        stats['offered_load'] = config['client_arrival_rate'] * threads * config['client_total']
+
     total_injected_failures = 0
     if 'inject_failure' in stats:
         total_injected_failures = stats['inject_failure']
@@ -452,6 +658,9 @@ def calculate_statistics_for_run(config, local_out_directory, run):
     stats['tx_attempted_failure_percentage'] = total_attempted_failures/stats['attempts']
 
     norm_op_latencies, norm_op_times = calculate_all_op_statistics(config, stats, region_op_latencies, region_op_times, region_op_latency_counts, region_op_tputs)
+    calculate_all_latency_hist_statistics(config, stats,
+            {k: v for k, v in stats.items() if is_latency_hist(k) and type(v) is list},
+            region_op_latencies, get_total_recorded_time(config))
     for k, v in norm_op_latencies.items():
         region_op_latencies['%s_norm' % k] = v
     for k, v in norm_op_times.items():
@@ -459,14 +668,19 @@ def calculate_statistics_for_run(config, local_out_directory, run):
     return stats, region_op_latencies, region_op_times, region_op_latency_counts, region_op_tputs, region_client_op_latencies, region_client_op_times
 
 
+def get_total_recorded_time(config):
+    return float(config['client_experiment_length'] - config['client_ramp_up'] - config['client_ramp_down'])
+
 def calculate_op_statistics(config, stats, total_recorded_time, op_type, latencies, norm_latencies, tput):
     if len(latencies) > 0:
+        # only every client_latency_sample_rate-th op is logged
+        ops = len(latencies) * get_latency_sample_rate(config)
         stats[op_type] = calculate_statistics_for_data(latencies)
-        stats[op_type]['ops'] = len(latencies)
+        stats[op_type]['ops'] = ops
         if tput == -1:
-            stats[op_type]['tput'] = len(latencies) / total_recorded_time
+            stats[op_type]['tput'] = ops / total_recorded_time
         else:
-            stats[op_type]['tput'] = len(latencies) / total_recorded_time
+            stats[op_type]['tput'] = ops / total_recorded_time
             stats[op_type]['new_tput'] = tput
 
             #added stat to compute tx/s/honest_client
@@ -478,14 +692,14 @@ def calculate_op_statistics(config, stats, total_recorded_time, op_type, latenci
                 stats[op_type]['tput_s_honest'] = stats[op_type]['tput']/total_honest
 
         if op_type == 'combined':
-            stats['combined']['ops'] = len(latencies)
+            stats['combined']['ops'] = ops
             stats['combined']['time'] = total_recorded_time
         if (not 'server_emulate_wan' in config or config['server_emulate_wan']) and len(norm_latencies) > 0:
             stats['%s_norm' % op_type] = calculate_statistics_for_data(norm_latencies)
             stats['%s_norm' % op_type]['samples'] = len(norm_latencies)
 
 def calculate_all_op_statistics(config, stats, region_op_latencies, region_op_times, region_op_latency_counts, region_op_tputs):
-    total_recorded_time = float(config['client_experiment_length'] - config['client_ramp_up'] - config['client_ramp_down'])
+    total_recorded_time = get_total_recorded_time(config)
 
     norm_op_latencies = {}
     norm_op_times = {}
@@ -505,7 +719,8 @@ def calculate_all_op_statistics(config, stats, region_op_latencies, region_op_ti
                 norm_op_latencies[k] = [v[i][idx] for idx in sample_idxs]
                 norm_op_times[k] = [region_op_times[k][i][idx] for idx in sample_idxs]
 
-        if not 'server_emulate_wan' in config or config['server_emulate_wan']:
+        # real multi-region deployments run without server_emulate_wan
+        if not 'server_emulate_wan' in config or config['server_emulate_wan'] or ('stats_region_breakdown' in config and config['stats_region_breakdown']):
             for i in range(len(v)):
                 region_key = 'region-%d' % i
                 if region_key not in stats:
@@ -994,7 +1209,8 @@ def generate_ot_plots(config, local_out_directory, stats, op_latencies, op_times
             if config['client_total'] == 1 and op_type.startswith('op'):
                 ops.append(op_type)
             if not op_type in config['client_cdf_plot_blacklist'] and not 'region-' in op_type:
-                if type(stats['runs'][i][op_type]) is dict:
+                # phase histograms have stats but no logged ops to plot over time
+                if type(stats['runs'][i][op_type]) is dict and op_type in op_latencies:
                     plot_name = 'run-%d-%s' % (i, op_type)
                     futures.append(executor.submit(generate_lot_plot, config,
                         plots_directory, 'lot-' + plot_name,
@@ -1016,7 +1232,7 @@ def generate_ot_plots(config, local_out_directory, stats, op_latencies, op_times
             elif 'region-' in op_type:
                 for op_type2 in stats['runs'][i][op_type]:
                     if not op_type2 in config['client_cdf_plot_blacklist']:
-                        if type(stats['runs'][i][op_type]) is dict:
+                        if type(stats['runs'][i][op_type]) is dict and op_type2 in op_latencies:
                             lot_plot_name = 'lot-run-%d-%s-%s' % (i, op_type, op_type2)
                             futures.append(executor.submit(generate_lot_plot,
                                 config, plots_directory, lot_plot_name,
@@ -139,11 +139,11 @@ def terminate_clients_on_timeout(timeout, cond, client_ssh_threads):
             c.terminate()
     cond.release()
 
-def wait_for_clients_to_terminate(config, client_ssh_threads):
+def wait_for_clients_to_terminate(config, client_ssh_threads, load_time=0):
     cond = threading.Condition()
     timeout_thread = threading.Thread(
             target=terminate_clients_on_timeout,
-            args=(config['client_experiment_length'] + 30,
+            args=(config['client_experiment_length'] + load_time + 30,
                 cond,
                 client_ssh_threads))
     timeout_thread.daemon = True
@@ -271,6 +271,22 @@ def start_servers(config, local_exp_directory, remote_exp_directory, run):
     time.sleep(1)
     return server_threads
 
+def start_in_process(config, local_exp_directory, run):
+    for i in range(len(config['server_names'])):
+        os.makedirs(os.path.join(local_exp_directory,
+            config['out_directory_name'], 'server-%d' % i), exist_ok=True)
+        for j in range(config['client_nodes_per_server']):
+            os.makedirs(os.path.join(local_exp_directory,
+                config['out_directory_name'], 'client-%d-%d' % (i, j)),
+                exist_ok=True)
+    in_process_command = get_in_process_cmd(config, run, local_exp_directory)
+    print(in_process_command)
+    return subprocess.Popen(in_process_command, shell=True)
+
+def kill_in_process(config):
+    kill_process_by_name(os.path.join(config['src_directory'],
+        config['bin_directory_name'], config['in_process_bin_name']), ' -9')
+
 def start_master(config, local_exp_directory, remote_exp_directory, run):
     if is_exp_remote(config):
         exp_directory = remote_exp_directory
@@ -417,10 +433,16 @@ def setup_delays(config, wan, executor):
 def get_local_path_to_bins(config):
     return os.path.join(config['src_directory'], config['bin_directory_name'])
 
-def copy_binaries_to_nfs(config, executor):
-    if 'remade_binaries' not in SERVERS_SETUP:
+# binaries are built once per sweep, and again whenever an experiment needs
+# different make_specialize flags than the last build
+def remake_binaries_if_needed(config):
+    spec_flags = get_spec_flags(config)
+    if 'remade_binaries' not in SERVERS_SETUP or SERVERS_SETUP['remade_binaries'] != spec_flags:
         remake_binaries(config)
-        SERVERS_SETUP['remade_binaries'] = True
+        SERVERS_SETUP['remade_binaries'] = spec_flags
+
+def copy_binaries_to_nfs(config, executor):
+    remake_binaries_if_needed(config)
     nfs_enabled = not 'remote_bin_directory_nfs_enabled' in config or config['remote_bin_directory_nfs_enabled']
     n = 1 if nfs_enabled else len(config['server_names'])
     futures = []
@@ -448,9 +470,21 @@ def is_exp_local(config):
 def is_exp_remote(config):
     return not is_exp_local(config)
 
+def is_exp_in_process(config):
+    return 'run_in_process' in config and config['run_in_process']
+
+# configs for settings that the current binaries do not define yet name the
+# missing support; they are refused here instead of failing on unknown flags
+def check_binary_support(config_file, config):
+    if 'requires_binary_support' in config:
+        sys.stderr.write('%s requires binary support that is still pending: %s.\n' % (
+            config_file, config['requires_binary_support']))
+        sys.exit(1)
+
 def run_experiment(config_file, client_config_idx, executor):
     with open(config_file) as f:
         config = json.load(f)
+        check_binary_support(config_file, config)
         if not 'server_regions' in config:
             config['server_regions'] = {}
             for server_name in config['server_names']:
@@ -467,6 +501,9 @@ def run_experiment(config_file, client_config_idx, executor):
             config['client_cdf_plot_blacklist'] = []
         if not 'client_total' in config:
             config['client_total'] = config['client_nodes_per_server'] * config['client_processes_per_client_node'] * len(config['server_names'])
+        if is_exp_in_process(config):
+            config['run_locally'] = True
+            config['use_master'] = False
 
         wan = 'server_emulate_wan' in config and (config['server_emulate_wan'] and (not 'run_locally' in config or not config['run_locally']))
         if not 'run_locally' in config or not config['run_locally']:
@@ -474,9 +511,7 @@ def run_experiment(config_file, client_config_idx, executor):
             setup_delays(config, wan, executor)
         kill_clients(config, executor)
         kill_servers(config, executor)
-        if 'remade_binaries' not in SERVERS_SETUP:
-            remake_binaries(config)
-            SERVERS_SETUP['remade_binaries'] = True
+        remake_binaries_if_needed(config)
         if is_exp_remote(config):
             copy_binaries_to_nfs(config, executor)
         setup_nodes(config)
@@ -490,6 +525,15 @@ def run_experiment(config_file, client_config_idx, executor):
             remote_exp_directory = prepare_remote_exp_directories(config, local_exp_directory, executor)
         kill_clients(config, executor)
         for i in range(config['num_experiment_runs']):
+            if is_exp_in_process(config):
+                kill_in_process(config)
+                in_process_thread = start_in_process(config, local_exp_directory, i)
+                # the process loads all replicas before it starts the clients
+                load_time = config['server_load_time'] if 'server_load_time' in config else 0
+                wait_for_clients_to_terminate(config, [in_process_thread], load_time)
+                kill_in_process(config)
+                time.sleep(1)
+                continue
             servers_alive = False
             retries = 0
             master_thread = None
@@ -538,6 +582,7 @@ def run_multiple_experiments(config_file, executor):
     out_dirs = None
     with open(config_file) as f:
         config = json.load(f)
+        check_binary_support(config_file, config)
 
         if not 'src_commit_hash' in config:
             config['src_commit_hash'] = get_current_branch(config['src_directory'])
@@ -27,23 +27,55 @@ import subprocess
 import os
 import shutil
 
+SPEC_FLAGS_FILE = '.spec_flags'
+
+def get_spec_flags(config):
+    # settings listed in make_specialize are compiled in as -DSPEC_<SETTING>=<value>
+    # (booleans as 0/1) instead of being checked as gflags at runtime
+    spec_flags = []
+    if 'make_specialize' in config:
+        for k in config['make_specialize']:
+            v = config['replication_protocol_settings'][k]
+            if type(v) is bool:
+                v = 1 if v else 0
+            elif type(v) is not int:
+                raise Exception('make_specialize setting %s must be a bool or an integer, not %s.' % (k, repr(v)))
+            spec_flags.append('-DSPEC_%s=%d' % (k.upper(), v))
+    return ' '.join(spec_flags)
+
 def compile_make(config):
     e = os.environ.copy()
     if 'make_env' in config:
         for k, v in config['make_env'].items():
             e[k] = v
-    if not 'make_clean' in config or config['make_clean']:
+    spec_flags = get_spec_flags(config)
+    if len(spec_flags) > 0:
+        e['SPEC_FLAGS'] = spec_flags
+    # objects built with different specialization flags cannot be reused; the
+    # flags of the last specialized build are kept next to the collected
+    # binaries, and a normal build removes them again
+    bin_path = os.path.join(config['src_directory'], 'bin')
+    spec_flags_file = os.path.join(bin_path, SPEC_FLAGS_FILE)
+    prev_spec_flags = ''
+    if os.path.exists(spec_flags_file):
+        with open(spec_flags_file) as f:
+            prev_spec_flags = f.read()
+    if not 'make_clean' in config or config['make_clean'] or spec_flags != prev_spec_flags:
         subprocess.call(["make", "-j", "8", "clean"], cwd=config['src_directory'])
     if 'make_args' in config:
         subprocess.call(["make", "-j", "8", config['make_args']], cwd=config['src_directory'], env=e)
     else:
         subprocess.call(["make", "-j", "8"], cwd=config['src_directory'], env=e)
-    bin_path = os.path.join(config['src_directory'], 'bin')
     os.makedirs(bin_path, exist_ok=True)
     if 'make_collect_bins' in config:
         for f in config['make_collect_bins']:
             shutil.copy2(os.path.join(config['src_directory'], f),
                 os.path.join(bin_path, os.path.basename(f)))
+    if len(spec_flags) > 0:
+        with open(spec_flags_file, 'w') as f:
+            f.write(spec_flags)
+    elif os.path.exists(spec_flags_file):
+        os.remove(spec_flags_file)
     return bin_path
 
 def get_current_branch(src_directory):
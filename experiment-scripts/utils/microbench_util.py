@@ -0,0 +1,115 @@
+'''
+ Copyright 2021 Matthew Burke <matthelb@cs.cornell.edu>
+                Florian Suri-Payer <fsp@cs.cornell.edu>
+
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+'''
+import json
+import os
+import subprocess
+
+from utils.git_util import *
+from utils.remote_util import *
+from utils.experiment_util import check_binary_support
+
+MICROBENCH_OUT_FILE = 'microbench.json'
+DEFAULT_REGRESSION_THRESHOLD = 10
+
+def run_microbenchmarks(config_file):
+    with open(config_file) as f:
+        config = json.load(f)
+    check_binary_support(config_file, config)
+    remake_binaries(config)
+    exp_directory = prepare_local_exp_directory(config, config_file)
+    out_file = os.path.join(exp_directory, MICROBENCH_OUT_FILE)
+    bench_bin = os.path.join(config['src_directory'], config['bin_directory_name'],
+            os.path.basename(config['microbench_bin_name']))
+    bench_cmd = [bench_bin,
+            '--benchmark_out=%s' % out_file,
+            '--benchmark_out_format=json']
+    if 'microbench_filter' in config:
+        bench_cmd.append('--benchmark_filter=%s' % config['microbench_filter'])
+    if 'microbench_repetitions' in config:
+        bench_cmd.append('--benchmark_repetitions=%d' % config['microbench_repetitions'])
+        bench_cmd.append('--benchmark_report_aggregates_only=true')
+    if 'microbench_min_time' in config:
+        # recent google benchmark versions require the unit suffix
+        bench_cmd.append('--benchmark_min_time=%gs' % config['microbench_min_time'])
+    if 'microbench_key_path' in config:
+        bench_cmd.append('--indicus_key_path=%s' % config['microbench_key_path'])
+    if 'microbench_pin_core' in config:
+        bench_cmd = ['taskset', '-c', str(config['microbench_pin_core'])] + bench_cmd
+    print(' '.join(bench_cmd))
+    subprocess.call(bench_cmd, cwd=exp_directory)
+    return config, out_file
+
+# google benchmark reports one entry per repetition, plus mean/median/stddev
+# entries ('run_type': 'aggregate') when run with repetitions; the median is
+# compared if it exists
+def load_microbenchmark_times(bench_file):
+    with open(bench_file) as f:
+        bench = json.load(f)
+    times = {}
+    for b in bench['benchmarks']:
+        if 'error_occurred' in b and b['error_occurred']:
+            continue
+        if 'run_type' in b and b['run_type'] == 'aggregate':
+            if b['aggregate_name'] != 'median':
+                continue
+            name = b['run_name']
+        else:
+            name = b['run_name'] if 'run_name' in b else b['name']
+            if name in times:
+                continue
+        times[name] = {'cpu_time': b['cpu_time'], 'real_time': b['real_time'],
+                'time_unit': b['time_unit']}
+    return times
+
+def compare_microbenchmarks(baseline_file, bench_file, threshold=DEFAULT_REGRESSION_THRESHOLD):
+    baseline = load_microbenchmark_times(baseline_file)
+    current = load_microbenchmark_times(bench_file)
+    regressions = []
+    print('%-60s %14s %14s %8s' % ('Benchmark', 'Baseline', 'Current', 'Change'))
+    for name in sorted(current):
+        if not name in baseline:
+            print('%-60s %14s %11.1f %2s %8s' % (name, '-', current[name]['cpu_time'],
+                current[name]['time_unit'], 'new'))
+            continue
+        if baseline[name]['time_unit'] != current[name]['time_unit']:
+            print('%-60s time unit changed from %s to %s' % (name,
+                baseline[name]['time_unit'], current[name]['time_unit']))
+            continue
+        change = 100 * (current[name]['cpu_time'] - baseline[name]['cpu_time']) / baseline[name]['cpu_time']
+        print('%-60s %11.1f %2s %11.1f %2s %+7.1f%%' % (name, baseline[name]['cpu_time'],
+            baseline[name]['time_unit'], current[name]['cpu_time'],
+            current[name]['time_unit'], change))
+        if change > threshold:
+            regressions.append(name)
+    for name in sorted(baseline):
+        if not name in current:
+            print('%-60s %11.1f %2s %14s %8s' % (name, baseline[name]['cpu_time'],
+                baseline[name]['time_unit'], '-', 'missing'))
+    if len(regressions) > 0:
+        print('%d benchmark(s) regressed by more than %d%%:' % (len(regressions), threshold))
+        for name in regressions:
+            print('  %s' % name)
+    return regressions